@@ -0,0 +1,652 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "batch.h"
+#include "cpu.h"
+
+// Whole vector of register x (or of the group mask) for lanes [chunk, chunk + BATCH_VECTOR_BYTES).
+#define LANE_ROW(batch, x, chunk) (*(LaneVec*)&(batch)->v[(x)][(chunk)])
+#define LANE_MASK(batch, chunk) (*(LaneVec*)&(batch)->group_mask[(chunk)])
+
+// Take `value` in lanes of the current group, keep `old` everywhere else.
+#define LANE_BLEND(old, value, mask) (((old) & ~(mask)) | ((value) & (mask)))
+
+// PCs and budgets are 16 bits wide, so a vector holds half as many lanes.
+#define LANES16 (BATCH_VECTOR_BYTES / 2)
+
+typedef uint8_t LaneHalf __attribute__((vector_size(LANES16), may_alias));
+
+// Widen lanes [chunk, chunk + LANES16) of a 0xFF/0x00 byte mask to 0xFFFF/0x0000.
+#define WIDE_MASK(mask, chunk) ((LaneVec16)(__builtin_convertvector(*(LaneHalf*)&(mask)[(chunk)], LaneVec16) != 0))
+
+int InitBatch(FishBatch* batch, int count, ConfigState* config) {
+    memset(batch, 0, sizeof(*batch));
+
+    batch->count = count;
+    batch->stride = (count + BATCH_VECTOR_BYTES - 1) / BATCH_VECTOR_BYTES * BATCH_VECTOR_BYTES;
+
+    // V0-VF and the group/skip masks share one aligned block.
+    uint8_t* registers = aligned_alloc(BATCH_VECTOR_BYTES, 18 * batch->stride);
+    batch->lanes = calloc(count, sizeof(Fish));
+    batch->pc = aligned_alloc(BATCH_VECTOR_BYTES, batch->stride * sizeof(uint16_t));
+    batch->budget = aligned_alloc(BATCH_VECTOR_BYTES, batch->stride * sizeof(uint16_t));
+    batch->i_reg = calloc(batch->stride, sizeof(uint16_t));
+    batch->rng_state = calloc(batch->stride, sizeof(uint32_t));
+
+    if (registers == NULL || batch->lanes == NULL || batch->pc == NULL || batch->budget == NULL ||
+        batch->i_reg == NULL || batch->rng_state == NULL) {
+        free(registers);
+        FreeBatch(batch);
+        return 0;
+    }
+
+    memset(batch->pc, 0, batch->stride * sizeof(uint16_t));
+    memset(batch->budget, 0, batch->stride * sizeof(uint16_t));
+
+    batch->written_start = MAX_MEMORY;
+    batch->written_end = 0;
+    batch->scalar_backoff = BATCH_SCALAR_CALLS;
+
+    memset(registers, 0, 18 * batch->stride);
+    for (int x = 0; x < 16; x++) {
+        batch->v[x] = &registers[x * batch->stride];
+    }
+    batch->group_mask = &registers[16 * batch->stride];
+    batch->skip_mask = &registers[17 * batch->stride];
+
+    for (int lane = 0; lane < count; lane++) {
+        InitFish(&batch->lanes[lane], config);
+
+        // Give every lane its own sequence; callers doing seed sweeps overwrite rng_state[lane].
+        batch->pc[lane] = batch->lanes[lane].pc;
+        batch->rng_state[lane] = (batch->lanes[lane].rng_state ^ (lane * 0x9E3779B9u)) | 1;
+    }
+
+    return 1;
+}
+
+void FreeBatch(FishBatch* batch) {
+    // v[0] is the start of the single register block.
+    free(batch->v[0]);
+    free(batch->lanes);
+    free(batch->pc);
+    free(batch->i_reg);
+    free(batch->rng_state);
+    free(batch->budget);
+    memset(batch, 0, sizeof(*batch));
+}
+
+int LoadBatchRom(FishBatch* batch, char* file_name) {
+    if (LoadRom(file_name, &batch->lanes[0].memory[ROM_START]) != 0) {
+        return 1;
+    }
+
+    for (int lane = 1; lane < batch->count; lane++) {
+        memcpy(&batch->lanes[lane].memory[ROM_START], &batch->lanes[0].memory[ROM_START], MAX_MEMORY - ROM_START);
+    }
+
+    return 0;
+}
+
+void UpdateBatchTimers(FishBatch* batch) {
+    for (int lane = 0; lane < batch->count; lane++) {
+        Fish* fish = &batch->lanes[lane];
+
+        if (fish->delay_timer > 0) {
+            fish->delay_timer--;
+        }
+
+        if (fish->sound_timer > 0) {
+            fish->sound_timer--;
+        }
+    }
+}
+
+static void MarkWritten(FishBatch* batch, int start, int length) {
+    int end = start + length > MAX_MEMORY ? MAX_MEMORY : start + length;
+
+    if (start < batch->written_start) batch->written_start = start;
+    if (end > batch->written_end) batch->written_end = end;
+}
+
+// Fold in the stores a lane made through the regular interpreter.
+static void MergeWritten(FishBatch* batch, Fish* fish) {
+    if (fish->written_start < batch->written_start) batch->written_start = fish->written_start;
+    if (fish->written_end > batch->written_end) batch->written_end = fish->written_end;
+}
+
+// Run up to `steps` instructions on a single lane through the regular interpreter.
+// Registers are copied in and out once, so detached lanes should be given as many steps as possible.
+static void RunLane(FishBatch* batch, int lane, int steps) {
+    Fish* fish = &batch->lanes[lane];
+
+    for (int x = 0; x < 16; x++) {
+        fish->v[x] = batch->v[x][lane];
+    }
+    fish->pc = batch->pc[lane];
+    fish->i_reg = batch->i_reg[lane];
+    fish->rng_state = batch->rng_state[lane];
+
+    for (int step = 0; step < steps && !fish->exit_requested; step++) {
+        EmulateCpu(fish, 0);
+    }
+    MergeWritten(batch, fish);
+
+    for (int x = 0; x < 16; x++) {
+        batch->v[x][lane] = fish->v[x];
+    }
+    batch->pc[lane] = fish->pc;
+    batch->i_reg[lane] = fish->i_reg;
+    batch->rng_state[lane] = fish->rng_state;
+}
+
+// Grouped lane whose operands fall outside what the group code mirrors (stack/memory/display overruns).
+static void StepLane(FishBatch* batch, int lane) {
+    RunLane(batch, lane, 1);
+
+    batch->budget[lane]--;
+    if (batch->lanes[lane].exit_requested) {
+        batch->budget[lane] = 0;
+    }
+}
+
+// Increment PC by 2 after each instruction, same as EmulateCpu.
+static void FinishLane(FishBatch* batch, int lane) {
+    batch->pc[lane] += 2;
+    batch->budget[lane]--;
+
+    if (batch->pc[lane] > MAX_MEMORY || batch->pc[lane] < ROM_START) {
+        puts("fuck up detected... exiting...");
+        batch->lanes[lane].exit_requested = 1;
+        batch->budget[lane] = 0;
+    }
+}
+
+// Group the lanes sitting at the lowest PC. Lanes further ahead wait, so lanes that took the other
+// side of a skip catch up and rejoin them instead of drifting apart.
+// Returns the number of lanes that still have steps left.
+static int SelectGroup(FishBatch* batch) {
+    LaneVec16 lowest = ~(LaneVec16){0};
+    LaneVec16 running = {0};
+
+    // Finished lanes read as PC 0xFFFF so they never win.
+    for (int chunk = 0; chunk < batch->stride; chunk += LANES16) {
+        LaneVec16 live = (LaneVec16)(*(LaneVec16*)&batch->budget[chunk] != 0);
+        LaneVec16 key = *(LaneVec16*)&batch->pc[chunk] | ~live;
+
+        lowest = LANE_BLEND(lowest, key, (LaneVec16)(key < lowest));
+        running -= live;
+    }
+
+    uint16_t pc = UINT16_MAX;
+    int running_count = 0;
+    for (int i = 0; i < LANES16; i++) {
+        if (lowest[i] < pc) pc = lowest[i];
+        running_count += running[i];
+    }
+
+    batch->group_count = 0;
+    if (running_count == 0) return 0;
+
+    LaneVec16 target = (LaneVec16){0} + pc;
+    LaneVec16 members = {0};
+    for (int chunk = 0; chunk < batch->stride; chunk += LANES16) {
+        LaneVec16 live = (LaneVec16)(*(LaneVec16*)&batch->budget[chunk] != 0);
+        LaneVec16 member = (LaneVec16)(*(LaneVec16*)&batch->pc[chunk] == target) & live;
+
+        *(LaneHalf*)&batch->group_mask[chunk] = __builtin_convertvector(member, LaneHalf);
+        members -= member;
+    }
+
+    for (int i = 0; i < LANES16; i++) {
+        batch->group_count += members[i];
+    }
+
+    // Self-modifying code: the opcode bytes may differ between lanes, so only keep lanes that match the first.
+    if (pc < MAX_MEMORY - 1 && pc + 1 >= batch->written_start && pc < batch->written_end) {
+        Fish* leader = NULL;
+
+        for (int lane = 0; lane < batch->count; lane++) {
+            if (!batch->group_mask[lane]) continue;
+
+            Fish* fish = &batch->lanes[lane];
+            if (leader == NULL) {
+                leader = fish;
+                batch->group_leader = lane;
+            } else if (fish->memory[pc] != leader->memory[pc] || fish->memory[pc + 1] != leader->memory[pc + 1]) {
+                batch->group_mask[lane] = 0x00;
+                batch->group_count--;
+            }
+        }
+    } else {
+        // Every lane still holds the ROM's bytes here.
+        batch->group_leader = 0;
+    }
+
+    batch->group_pc = pc;
+
+    return running_count;
+}
+
+// Step every group lane past its instruction, plus the skip for lanes marked in skip_mask.
+static void FinishGroup(FishBatch* batch, int with_skip) {
+    LaneVec16 faults = {0};
+
+    for (int chunk = 0; chunk < batch->stride; chunk += LANES16) {
+        LaneVec16 mask = WIDE_MASK(batch->group_mask, chunk);
+        LaneVec16 step = mask & 2;
+
+        if (with_skip) {
+            step += WIDE_MASK(batch->skip_mask, chunk) & 2;
+        }
+
+        LaneVec16 pc = *(LaneVec16*)&batch->pc[chunk] + step;
+        *(LaneVec16*)&batch->pc[chunk] = pc;
+        *(LaneVec16*)&batch->budget[chunk] += mask;
+        faults |= mask & ((LaneVec16)(pc > MAX_MEMORY) | (LaneVec16)(pc < ROM_START));
+    }
+
+    int any_fault = 0;
+    for (int i = 0; i < LANES16; i++) {
+        any_fault |= faults[i];
+    }
+    if (!any_fault) return;
+
+    for (int lane = 0; lane < batch->count; lane++) {
+        if (batch->group_mask[lane] && (batch->pc[lane] > MAX_MEMORY || batch->pc[lane] < ROM_START)) {
+            puts("fuck up detected... exiting...");
+            batch->lanes[lane].exit_requested = 1;
+            batch->budget[lane] = 0;
+        }
+    }
+}
+
+// Execute the instruction at the group's PC once for every lane in the group. Register-only opcodes
+// are vectorised across lanes; the rest loop over the group reading the SoA registers directly.
+static void EmulateGroup(FishBatch* batch) {
+    uint16_t pc = batch->group_pc;
+
+    // Leave the edge of memory to the interpreter and its fault handling.
+    if (pc >= MAX_MEMORY - 1) {
+        for (int lane = 0; lane < batch->count; lane++) {
+            if (batch->group_mask[lane]) StepLane(batch, lane);
+        }
+        return;
+    }
+
+    uint8_t high = batch->lanes[batch->group_leader].memory[pc];
+    uint8_t low = batch->lanes[batch->group_leader].memory[pc + 1];
+    uint8_t x = high & 0x0F;
+    uint8_t y = low >> 4;
+    uint8_t n = low & 0x0F;
+    uint16_t address = (x << 8) | low;
+
+    switch (high >> 4) {
+        case 0x0: {
+            for (int lane = 0; lane < batch->count; lane++) {
+                if (!batch->group_mask[lane]) continue;
+                Fish* fish = &batch->lanes[lane];
+
+                if (low == 0xE0) {
+                    memset(&fish->display[0][0], 0, sizeof(fish->display));
+                } else if (low == 0xEE && fish->sp > 0 && fish->sp <= STACK_SIZE) {
+                    fish->sp--;
+                    batch->pc[lane] = fish->stack[fish->sp];
+                } else {
+                    StepLane(batch, lane);
+                    continue;
+                }
+                FinishLane(batch, lane);
+            }
+        } return;
+        case 0x1: {
+            LaneVec16 target = (LaneVec16){0} + (uint16_t)(address - 2);
+            for (int chunk = 0; chunk < batch->stride; chunk += LANES16) {
+                LaneVec16* lane_pc = (LaneVec16*)&batch->pc[chunk];
+                *lane_pc = LANE_BLEND(*lane_pc, target, WIDE_MASK(batch->group_mask, chunk));
+            }
+        } break;
+        case 0x2: {
+            for (int lane = 0; lane < batch->count; lane++) {
+                if (!batch->group_mask[lane]) continue;
+                Fish* fish = &batch->lanes[lane];
+
+                if (fish->sp >= STACK_SIZE) {
+                    StepLane(batch, lane);
+                    continue;
+                }
+                fish->stack[fish->sp] = batch->pc[lane];
+                fish->sp++;
+                batch->pc[lane] = address - 2;
+                FinishLane(batch, lane);
+            }
+        } return;
+        case 0x3: case 0x4: case 0x5: case 0x9: {
+            for (int chunk = 0; chunk < batch->stride; chunk += BATCH_VECTOR_BYTES) {
+                LaneVec vx = LANE_ROW(batch, x, chunk);
+                LaneVec operand = (LaneVec){0} + low;
+                if ((high >> 4) == 0x5 || (high >> 4) == 0x9) {
+                    operand = LANE_ROW(batch, y, chunk);
+                }
+
+                LaneVec equal = (LaneVec)(vx == operand);
+                LaneVec skip = ((high >> 4) == 0x3 || (high >> 4) == 0x5) ? equal : ~equal;
+                *(LaneVec*)&batch->skip_mask[chunk] = skip & LANE_MASK(batch, chunk);
+            }
+            FinishGroup(batch, 1);
+        } return;
+        case 0x6: {
+            for (int chunk = 0; chunk < batch->stride; chunk += BATCH_VECTOR_BYTES) {
+                LaneVec value = {0};
+                value += low;
+                LANE_ROW(batch, x, chunk) = LANE_BLEND(LANE_ROW(batch, x, chunk), value, LANE_MASK(batch, chunk));
+            }
+        } break;
+        case 0x7: {
+            for (int chunk = 0; chunk < batch->stride; chunk += BATCH_VECTOR_BYTES) {
+                LaneVec vx = LANE_ROW(batch, x, chunk);
+                LANE_ROW(batch, x, chunk) = LANE_BLEND(vx, vx + low, LANE_MASK(batch, chunk));
+            }
+        } break;
+        case 0x8: {
+            if (n > 0x7 && n != 0xE) {
+                for (int lane = 0; lane < batch->count; lane++) {
+                    if (batch->group_mask[lane]) StepLane(batch, lane);
+                }
+                return;
+            }
+
+            // Statement order mirrors EmulateCpu so x == y and x == F behave identically.
+            for (int chunk = 0; chunk < batch->stride; chunk += BATCH_VECTOR_BYTES) {
+                LaneVec mask = LANE_MASK(batch, chunk);
+                LaneVec tempX = LANE_ROW(batch, x, chunk);
+                LaneVec vy = LANE_ROW(batch, y, chunk);
+
+                switch (n) {
+                    case 0x0: LANE_ROW(batch, x, chunk) = LANE_BLEND(tempX, vy, mask); break;
+                    case 0x1: LANE_ROW(batch, x, chunk) = LANE_BLEND(tempX, tempX | vy, mask); break;
+                    case 0x2: LANE_ROW(batch, x, chunk) = LANE_BLEND(tempX, tempX & vy, mask); break;
+                    case 0x3: LANE_ROW(batch, x, chunk) = LANE_BLEND(tempX, tempX ^ vy, mask); break;
+                    case 0x4: {
+                        LaneVec sum = tempX + vy;
+                        LANE_ROW(batch, x, chunk) = LANE_BLEND(tempX, sum, mask);
+                        LANE_ROW(batch, 0xF, chunk) = LANE_BLEND(LANE_ROW(batch, 0xF, chunk), (LaneVec)(sum < tempX) & 1, mask);
+                    } break;
+                    case 0x5: {
+                        LANE_ROW(batch, x, chunk) = LANE_BLEND(tempX, tempX - vy, mask);
+                        LaneVec flag = (LaneVec)(tempX >= LANE_ROW(batch, y, chunk)) & 1;
+                        LANE_ROW(batch, 0xF, chunk) = LANE_BLEND(LANE_ROW(batch, 0xF, chunk), flag, mask);
+                    } break;
+                    case 0x6: {
+                        LANE_ROW(batch, x, chunk) = LANE_BLEND(tempX, tempX >> 1, mask);
+                        LANE_ROW(batch, 0xF, chunk) = LANE_BLEND(LANE_ROW(batch, 0xF, chunk), tempX & 0x01, mask);
+                    } break;
+                    case 0x7: {
+                        LANE_ROW(batch, x, chunk) = LANE_BLEND(tempX, vy - tempX, mask);
+                        LaneVec flag = (LaneVec)(LANE_ROW(batch, y, chunk) >= tempX) & 1;
+                        LANE_ROW(batch, 0xF, chunk) = LANE_BLEND(LANE_ROW(batch, 0xF, chunk), flag, mask);
+                    } break;
+                    case 0xE: {
+                        LANE_ROW(batch, x, chunk) = LANE_BLEND(tempX, tempX << 1, mask);
+                        LANE_ROW(batch, 0xF, chunk) = LANE_BLEND(LANE_ROW(batch, 0xF, chunk), (tempX & 0x80) >> 7, mask);
+                    } break;
+                }
+            }
+        } break;
+        case 0xa: {
+            for (int lane = 0; lane < batch->count; lane++) {
+                if (batch->group_mask[lane]) batch->i_reg[lane] = address;
+            }
+        } break;
+        case 0xb: {
+            for (int lane = 0; lane < batch->count; lane++) {
+                if (batch->group_mask[lane]) batch->pc[lane] = address + batch->v[0][lane];
+            }
+        } break;
+        case 0xc: {
+            for (int lane = 0; lane < batch->count; lane++) {
+                if (batch->group_mask[lane]) {
+                    batch->v[x][lane] = (Xorshift32(&batch->rng_state[lane]) % UINT8_MAX) & low;
+                }
+            }
+        } break;
+        case 0xd: {
+            for (int lane = 0; lane < batch->count; lane++) {
+                if (!batch->group_mask[lane]) continue;
+                Fish* fish = &batch->lanes[lane];
+                uint8_t x_coord = batch->v[x][lane];
+                uint8_t y_coord = batch->v[y][lane];
+                uint16_t i_reg = batch->i_reg[lane];
+
+                // Sprites past the end of memory or of the display array run through the interpreter.
+                if (n > 0 && (i_reg + n > MAX_MEMORY ||
+                    (y_coord + n - 1) * DISPLAY_WIDTH + x_coord + 7 >= DISPLAY_WIDTH * DISPLAY_HEIGHT)) {
+                    StepLane(batch, lane);
+                    continue;
+                }
+
+                batch->v[0xF][lane] = 0;
+                for (int row = 0; row < n; row++) {
+                    for (int col = 0; col < 8; col++) {
+                        int sprite_bit = (fish->memory[i_reg + row] >> (7 - col)) & 0x1;
+
+                        if (sprite_bit && fish->display[y_coord + row][x_coord + col]) {
+                            batch->v[0xF][lane] = 1;
+                        }
+                        fish->display[y_coord + row][x_coord + col] ^= sprite_bit;
+                    }
+                }
+
+                fish->draw_requested = 1;
+                FinishLane(batch, lane);
+            }
+        } return;
+        case 0xe: {
+            for (int lane = 0; lane < batch->count; lane++) {
+                if (!batch->group_mask[lane]) continue;
+                uint8_t key = batch->v[x][lane];
+
+                if ((low != 0x9E && low != 0xA1) || key >= sizeof(batch->lanes[lane].keypad)) {
+                    StepLane(batch, lane);
+                    continue;
+                }
+
+                int pressed = batch->lanes[lane].keypad[key] != 0;
+                if (low == 0x9E ? pressed : !pressed) {
+                    batch->pc[lane] += 2;
+                }
+                FinishLane(batch, lane);
+            }
+        } return;
+        case 0xf: {
+            for (int lane = 0; lane < batch->count; lane++) {
+                if (!batch->group_mask[lane]) continue;
+                Fish* fish = &batch->lanes[lane];
+                uint16_t i_reg = batch->i_reg[lane];
+
+                switch (low) {
+                    case 0x07: batch->v[x][lane] = fish->delay_timer; break;
+                    case 0x0A: {
+                        for (uint8_t key = 0; key < sizeof(fish->keypad); key++) {
+                            if (fish->keypad[key] == 0 && fish->keypad_buffer[key] == 1) {
+                                batch->v[x][lane] = key;
+                                batch->pc[lane] += 2;
+                                break;
+                            }
+                        }
+                        memcpy(&fish->keypad_buffer[0], &fish->keypad[0], sizeof(fish->keypad));
+                        batch->pc[lane] -= 2;
+                    } break;
+                    case 0x15: fish->delay_timer = batch->v[x][lane]; break;
+                    case 0x18: fish->sound_timer = batch->v[x][lane]; break;
+                    case 0x1E: batch->i_reg[lane] += batch->v[x][lane]; break;
+                    case 0x29: batch->i_reg[lane] = FONT_START + (x * FONT_STRIDE); break;
+                    case 0x33: {
+                        if (i_reg + 3 > MAX_MEMORY) {
+                            StepLane(batch, lane);
+                            continue;
+                        }
+                        MarkWritten(batch, i_reg, 3);
+                        fish->memory[i_reg] = (batch->v[x][lane] / 100);
+                        fish->memory[i_reg + 1] = (batch->v[x][lane] / 10) % 10;
+                        fish->memory[i_reg + 2] = batch->v[x][lane] % 10;
+                    } break;
+                    case 0x55: {
+                        if (i_reg + x + 1 > MAX_MEMORY) {
+                            StepLane(batch, lane);
+                            continue;
+                        }
+                        MarkWritten(batch, i_reg, x + 1);
+                        for (int j = 0; j <= x; j++) {
+                            fish->memory[i_reg + j] = batch->v[j][lane];
+                        }
+                    } break;
+                    case 0x65: {
+                        if (i_reg + x + 1 > MAX_MEMORY) {
+                            StepLane(batch, lane);
+                            continue;
+                        }
+                        for (int j = 0; j <= x; j++) {
+                            batch->v[j][lane] = fish->memory[i_reg + j];
+                        }
+                    } break;
+                    default: {
+                        StepLane(batch, lane);
+                        continue;
+                    }
+                }
+                FinishLane(batch, lane);
+            }
+        } return;
+    }
+
+    FinishGroup(batch, 0);
+}
+
+// Run `steps` (at most UINT16_MAX) instructions on every live lane. Each step executes the lanes that share the
+// lowest PC together; small groups of stragglers are detached and finish their steps in the scalar interpreter.
+static void RunLockstep(FishBatch* batch, int steps) {
+    for (int lane = 0; lane < batch->count; lane++) {
+        batch->budget[lane] = batch->lanes[lane].exit_requested ? 0 : steps;
+    }
+
+    int live = -1;
+    int detached = 0;
+    int running;
+    while ((running = SelectGroup(batch)) > 0) {
+        if (live < 0) live = running;
+        batch->group_slots += live;
+
+        if (batch->group_count * BATCH_DETACH_RATIO >= running) {
+            batch->group_steps += batch->group_count;
+            EmulateGroup(batch);
+            continue;
+        }
+
+        // Lanes have scattered too far for vector steps to pay off, finish everyone scalar.
+        if (++detached > BATCH_MAX_DETACH) {
+            for (int lane = 0; lane < batch->count; lane++) {
+                if (batch->budget[lane] > 0) {
+                    RunLane(batch, lane, batch->budget[lane]);
+                    batch->budget[lane] = 0;
+                }
+            }
+            break;
+        }
+
+        for (int lane = 0; lane < batch->count; lane++) {
+            if (batch->group_mask[lane]) {
+                RunLane(batch, lane, batch->budget[lane]);
+                batch->budget[lane] = 0;
+            }
+        }
+    }
+}
+
+void SyncBatch(FishBatch* batch) {
+    if (!batch->scalar) return;
+
+    for (int lane = 0; lane < batch->count; lane++) {
+        Fish* fish = &batch->lanes[lane];
+
+        for (int x = 0; x < 16; x++) {
+            batch->v[x][lane] = fish->v[x];
+        }
+        batch->pc[lane] = fish->pc;
+        batch->i_reg[lane] = fish->i_reg;
+        batch->rng_state[lane] = fish->rng_state;
+    }
+}
+
+static void EnterScalar(FishBatch* batch) {
+    for (int lane = 0; lane < batch->count; lane++) {
+        Fish* fish = &batch->lanes[lane];
+
+        for (int x = 0; x < 16; x++) {
+            fish->v[x] = batch->v[x][lane];
+        }
+        fish->pc = batch->pc[lane];
+        fish->i_reg = batch->i_reg[lane];
+        fish->rng_state = batch->rng_state[lane];
+    }
+
+    batch->scalar = 1;
+    batch->scalar_calls = batch->scalar_backoff;
+    batch->lockstep_calls = 0;
+    if (batch->scalar_backoff < BATCH_MAX_SCALAR_CALLS) {
+        batch->scalar_backoff *= 2;
+    }
+}
+
+static void LeaveScalar(FishBatch* batch) {
+    SyncBatch(batch);
+
+    for (int lane = 0; lane < batch->count; lane++) {
+        MergeWritten(batch, &batch->lanes[lane]);
+    }
+
+    // Judge the retry on its own, not on the history that caused the switch.
+    batch->group_steps = 0;
+    batch->group_slots = 0;
+    batch->scalar = 0;
+}
+
+// Run `steps` instructions on every live lane, in lockstep while the lanes stay together and as independent
+// interpreter loops while they have scattered.
+void EmulateBatch(FishBatch* batch, int steps) {
+    if (batch->scalar && batch->scalar_calls > 0) {
+        batch->scalar_calls--;
+
+        for (int lane = 0; lane < batch->count; lane++) {
+            Fish* fish = &batch->lanes[lane];
+            for (int step = 0; step < steps && !fish->exit_requested; step++) {
+                EmulateCpu(fish, 0);
+            }
+        }
+        return;
+    }
+
+    if (batch->scalar) {
+        LeaveScalar(batch);
+    }
+
+    batch->group_steps -= batch->group_steps / BATCH_GROUP_WINDOW;
+    batch->group_slots -= batch->group_slots / BATCH_GROUP_WINDOW;
+
+    // Budgets are 16 bits wide, so long runs go in several passes.
+    for (; steps > 0; steps -= UINT16_MAX) {
+        RunLockstep(batch, steps < UINT16_MAX ? steps : UINT16_MAX);
+    }
+
+    if (batch->group_steps * BATCH_GROUP_RATIO < batch->group_slots) {
+        EnterScalar(batch);
+    } else if (++batch->lockstep_calls >= BATCH_SCALAR_CALLS) {
+        // Lanes have stayed together for a while, so the next scatter gets a shorter scalar stretch.
+        batch->lockstep_calls = 0;
+        if (batch->scalar_backoff > BATCH_SCALAR_CALLS) {
+            batch->scalar_backoff /= 2;
+        }
+    }
+}
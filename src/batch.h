@@ -0,0 +1,80 @@
+#include "fish.h"
+
+#ifndef BATCH_H
+#define BATCH_H
+
+// Lanes are padded to a multiple of the native vector width: AVX2 (`make avx2`) or SSE2/NEON otherwise.
+// Wider GCC vectors than the target supports get split up badly, so don't force 32 bytes.
+#ifdef __AVX2__
+#define BATCH_VECTOR_BYTES 32
+#else
+#define BATCH_VECTOR_BYTES 16
+#endif
+
+// A group smaller than 1/BATCH_DETACH_RATIO of the running lanes finishes its steps in the scalar interpreter.
+// After BATCH_MAX_DETACH such groups in one call every remaining lane does.
+#define BATCH_DETACH_RATIO 8
+#define BATCH_MAX_DETACH 4
+
+// Lockstep only pays off while groups average at least 1/BATCH_GROUP_RATIO of the live lanes, measured over
+// roughly the last BATCH_GROUP_WINDOW calls. Below that the batch switches to plain per-lane interpreter loops for
+// BATCH_SCALAR_CALLS calls, doubling up to BATCH_MAX_SCALAR_CALLS each time the retry still finds them scattered.
+#define BATCH_GROUP_RATIO 2
+#define BATCH_GROUP_WINDOW 8
+#define BATCH_SCALAR_CALLS 16
+#define BATCH_MAX_SCALAR_CALLS 1024
+
+typedef uint8_t LaneVec __attribute__((vector_size(BATCH_VECTOR_BYTES), may_alias));
+typedef uint16_t LaneVec16 __attribute__((vector_size(BATCH_VECTOR_BYTES), may_alias));
+
+typedef struct {
+    // Number of instances and the padded length of every per-lane array.
+    int count;
+    int stride;
+
+    // Per-lane memory, display, stack, timers and keypad.
+    // The registers below are the live copy; the ones in here are only synced around scalar steps.
+    Fish* lanes;
+
+    // Set while the lanes have scattered: the registers in lanes[] are live and the ones below are stale until
+    // SyncBatch. EmulateBatch calls left before lockstep is retried, the length of the next scalar stretch and
+    // the lockstep calls since the last switch.
+    int scalar;
+    int scalar_calls;
+    int scalar_backoff;
+    int lockstep_calls;
+
+    // Decaying totals of lane steps run in groups, and of live lanes summed over every group step.
+    long group_steps;
+    long group_slots;
+
+    // Hot registers in structure-of-arrays layout: v[x][lane], pc[lane], ...
+    uint8_t* v[16];
+    uint16_t* pc;
+    uint16_t* i_reg;
+    uint32_t* rng_state;
+
+    // Instructions each lane still has to run in the current lockstep pass. EmulateBatch splits longer
+    // calls into passes of at most UINT16_MAX steps.
+    uint16_t* budget;
+
+    // 0xFF for lanes in the group being executed, 0x00 elsewhere. skip_mask marks group lanes that take a skip.
+    uint8_t* group_mask;
+    uint8_t* skip_mask;
+    int group_count;
+    int group_leader;
+    uint16_t group_pc;
+
+    // Span of memory any lane has written to. Outside of it, every lane still holds the same ROM bytes.
+    uint16_t written_start;
+    uint16_t written_end;
+} FishBatch;
+
+int InitBatch(FishBatch*, int, ConfigState*);
+void FreeBatch(FishBatch*);
+int LoadBatchRom(FishBatch*, char*);
+void EmulateBatch(FishBatch*, int);
+void SyncBatch(FishBatch*);
+void UpdateBatchTimers(FishBatch*);
+
+#endif // BATCH_H
@@ -0,0 +1,216 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "capture.h"
+
+// Canonical 44 byte PCM header. Sizes are patched in once the writer has finished.
+static void WriteWavHeader(FILE* file, uint32_t samples) {
+    uint32_t data_size = samples * sizeof(int16_t);
+    uint32_t riff_size = 36 + data_size;
+    uint32_t format_size = 16;
+    uint16_t format = 1;
+    uint16_t channels = 1;
+    uint32_t sample_rate = AUDIO_FREQUENCY;
+    uint32_t byte_rate = AUDIO_FREQUENCY * sizeof(int16_t);
+    uint16_t block_align = sizeof(int16_t);
+    uint16_t bits = 16;
+
+    fwrite("RIFF", 4, 1, file);
+    fwrite(&riff_size, sizeof(riff_size), 1, file);
+    fwrite("WAVEfmt ", 8, 1, file);
+    fwrite(&format_size, sizeof(format_size), 1, file);
+    fwrite(&format, sizeof(format), 1, file);
+    fwrite(&channels, sizeof(channels), 1, file);
+    fwrite(&sample_rate, sizeof(sample_rate), 1, file);
+    fwrite(&byte_rate, sizeof(byte_rate), 1, file);
+    fwrite(&block_align, sizeof(block_align), 1, file);
+    fwrite(&bits, sizeof(bits), 1, file);
+    fwrite("data", 4, 1, file);
+    fwrite(&data_size, sizeof(data_size), 1, file);
+}
+
+static void WriteRun(CaptureState* capture, CaptureRun* run) {
+    uint8_t pixels[DISPLAY_HEIGHT * DISPLAY_WIDTH];
+    int16_t samples[CAPTURE_FRAME_SAMPLES];
+
+    for (int i = 0; i < DISPLAY_HEIGHT; i++) {
+        for (int j = 0; j < DISPLAY_WIDTH; j++) {
+            pixels[i * DISPLAY_WIDTH + j] = run->display[i][j] * UINT8_MAX;
+        }
+    }
+
+    for (uint32_t frame = 0; frame < run->frames; frame++) {
+        fputs("FRAME\n", capture->video);
+        fwrite(pixels, sizeof(pixels), 1, capture->video);
+
+        if (capture->audio == NULL) continue;
+
+        // Same tone the audio device plays while the sound timer is running.
+        for (int i = 0; i < CAPTURE_FRAME_SAMPLES; i++) {
+            samples[i] = run->sound ? apply_volume(gen_square(440, capture->audio_samples % AUDIO_FREQUENCY), 0.5) : 0;
+            capture->audio_samples++;
+        }
+        fwrite(samples, sizeof(samples), 1, capture->audio);
+    }
+}
+
+static int CaptureWriter(void* data) {
+    CaptureState* capture = data;
+    CaptureRun run;
+
+    while (1) {
+        SDL_LockMutex(capture->lock);
+        while (capture->queue_count == 0 && !capture->closing) {
+            SDL_CondWait(capture->ready, capture->lock);
+        }
+
+        if (capture->queue_count == 0) {
+            SDL_UnlockMutex(capture->lock);
+            break;
+        }
+
+        run = capture->queue[capture->queue_head];
+        capture->queue_head = (capture->queue_head + 1) % CAPTURE_QUEUE_SIZE;
+        capture->queue_count--;
+        SDL_CondSignal(capture->drained);
+        SDL_UnlockMutex(capture->lock);
+
+        // File I/O happens outside the lock so the emulation loop never waits on it.
+        WriteRun(capture, &run);
+    }
+
+    return 0;
+}
+
+// Hand the current run to the writer. When the queue is full this waits if `wait` is set, else returns 0.
+static int PushRun(CaptureState* capture, int wait) {
+    SDL_LockMutex(capture->lock);
+    while (capture->queue_count == CAPTURE_QUEUE_SIZE) {
+        if (!wait) {
+            SDL_UnlockMutex(capture->lock);
+            return 0;
+        }
+        SDL_CondWait(capture->drained, capture->lock);
+    }
+
+    int tail = (capture->queue_head + capture->queue_count) % CAPTURE_QUEUE_SIZE;
+    capture->queue[tail] = capture->current;
+    capture->queue_count++;
+    SDL_CondSignal(capture->ready);
+    SDL_UnlockMutex(capture->lock);
+
+    return 1;
+}
+
+// Close whatever StartCapture managed to open. Safe on a partially started capture.
+static void CloseCapture(CaptureState* capture) {
+    if (capture->audio != NULL) {
+        fseek(capture->audio, 0L, SEEK_SET);
+        WriteWavHeader(capture->audio, capture->audio_samples);
+        fclose(capture->audio);
+    }
+
+    if (capture->video != NULL) {
+        fclose(capture->video);
+    }
+
+    if (capture->drained != NULL) SDL_DestroyCond(capture->drained);
+    if (capture->ready != NULL) SDL_DestroyCond(capture->ready);
+    if (capture->lock != NULL) SDL_DestroyMutex(capture->lock);
+
+    capture->audio = NULL;
+    capture->video = NULL;
+    capture->drained = NULL;
+    capture->ready = NULL;
+    capture->lock = NULL;
+}
+
+int StartCapture(CaptureState* capture, int with_audio, int blocking) {
+    memset(capture, 0, sizeof(*capture));
+    capture->blocking = blocking;
+
+    capture->video = fopen(CAPTURE_VIDEO_FILE, "wb");
+    if (capture->video == NULL) {
+        puts("Failed to open " CAPTURE_VIDEO_FILE "...");
+        return 0;
+    }
+    fprintf(capture->video, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 Cmono\n", DISPLAY_WIDTH, DISPLAY_HEIGHT, REFRESH_RATE);
+
+    if (with_audio) {
+        capture->audio = fopen(CAPTURE_AUDIO_FILE, "wb");
+        if (capture->audio == NULL) {
+            puts("Failed to open " CAPTURE_AUDIO_FILE "...");
+            CloseCapture(capture);
+            return 0;
+        }
+        WriteWavHeader(capture->audio, 0);
+    }
+
+    capture->lock = SDL_CreateMutex();
+    capture->ready = SDL_CreateCond();
+    capture->drained = SDL_CreateCond();
+    if (capture->lock == NULL || capture->ready == NULL || capture->drained == NULL) {
+        puts("Failed to start capture thread...");
+        CloseCapture(capture);
+        return 0;
+    }
+
+    // Created last so the writer never sees a half built state.
+    capture->thread = SDL_CreateThread(CaptureWriter, "capture", capture);
+    if (capture->thread == NULL) {
+        puts("Failed to start capture thread...");
+        CloseCapture(capture);
+        return 0;
+    }
+
+    return 1;
+}
+
+// Called once per emulated frame. Identical frames only bump the run length, no copy is queued.
+void CaptureFrame(CaptureState* capture, Fish* state) {
+    uint8_t sound = state->sound_timer > 0;
+
+    if (capture->current.frames > 0 && capture->current.sound == sound &&
+        memcmp(capture->current.display, state->display, sizeof(state->display)) == 0) {
+        capture->current.frames++;
+        return;
+    }
+
+    // Writer has fallen behind: a windowed run holds the previous picture rather than stall emulation.
+    if (capture->current.frames > 0 && !PushRun(capture, capture->blocking)) {
+        if (capture->dropped == 0) {
+            fputs("Capture queue overflowed, frames are being dropped...\n", stderr);
+        }
+        capture->dropped++;
+        capture->current.frames++;
+        return;
+    }
+
+    memcpy(capture->current.display, state->display, sizeof(state->display));
+    capture->current.sound = sound;
+    capture->current.frames = 1;
+}
+
+// Returns the number of frames that were dropped, so callers can fail an incomplete recording.
+int StopCapture(CaptureState* capture) {
+    // Shutdown always waits for the writer.
+    if (capture->current.frames > 0) {
+        PushRun(capture, 1);
+    }
+
+    SDL_LockMutex(capture->lock);
+    capture->closing = 1;
+    SDL_CondSignal(capture->ready);
+    SDL_UnlockMutex(capture->lock);
+    SDL_WaitThread(capture->thread, NULL);
+
+    CloseCapture(capture);
+
+    if (capture->dropped > 0) {
+        fprintf(stderr, "Capture incomplete: %u frames were dropped and replaced by repeats.\n", capture->dropped);
+    }
+
+    return capture->dropped;
+}
@@ -0,0 +1,53 @@
+#include "fish.h"
+
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#define CAPTURE_QUEUE_SIZE 64
+#define CAPTURE_VIDEO_FILE "capture.y4m"
+#define CAPTURE_AUDIO_FILE "capture.wav"
+
+// Audio samples written per emulated frame.
+#define CAPTURE_FRAME_SAMPLES (AUDIO_FREQUENCY / REFRESH_RATE)
+
+typedef struct {
+    uint8_t display[DISPLAY_HEIGHT][DISPLAY_WIDTH];
+    uint8_t sound;
+
+    // Number of consecutive frames this picture/sound state was held for.
+    uint32_t frames;
+} CaptureRun;
+
+typedef struct {
+    FILE* video;
+    FILE* audio;
+
+    // Bounded queue between the emulation loop and the writer thread.
+    CaptureRun queue[CAPTURE_QUEUE_SIZE];
+    int queue_head;
+    int queue_count;
+    int closing;
+
+    // Wait for room in the queue instead of dropping frames. Set for headless runs.
+    int blocking;
+
+    SDL_mutex* lock;
+    SDL_cond* ready;
+    SDL_cond* drained;
+    SDL_Thread* thread;
+
+    // Run still being extended by identical frames. Owned by the emulation loop.
+    CaptureRun current;
+
+    // Frames that arrived while the queue was full and were held as a repeat instead. Never set when blocking.
+    uint32_t dropped;
+
+    // Writer thread only.
+    uint32_t audio_samples;
+} CaptureState;
+
+int StartCapture(CaptureState*, int, int);
+void CaptureFrame(CaptureState*, Fish*);
+int StopCapture(CaptureState*);
+
+#endif // CAPTURE_H
@@ -2,14 +2,85 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
-#include <time.h>
 
 #include "cpu.h"
 
-void EmulateCpu(Fish* device, int is_debug) {
-    // Seed RNG
-    srand(time(NULL));
+void InitFish(Fish* state, ConfigState* config) {
+    memset(state->display, 0, sizeof(state->display));
+    state->pc = ROM_START;
+    state->sp = 0;
+
+    if (config->deviceFreqency != 0) {
+        state->frequency = config->deviceFreqency;
+    } else state->frequency = 500;
+
+    state->exit_requested = 0;
+    state->written_start = MAX_MEMORY;
+    state->written_end = 0;
+
+    // Headless runs use a fixed seed so the same ROM always records the same capture.
+    state->rng_state = config->headlessMode ? 1 : ((uint32_t)time(NULL) | 1);
+
+    uint8_t font_array[] = {
+        0xF0, 0x90, 0x90, 0x90, 0xF0, // 0
+        0x20, 0x60, 0x20, 0x20, 0x70, // 1
+        0xF0, 0x10, 0xF0, 0x80, 0xF0, // 2
+        0xF0, 0x10, 0xF0, 0x10, 0xF0, // 3
+        0x90, 0x90, 0xF0, 0x10, 0x10, // 4
+        0xF0, 0x80, 0xF0, 0x10, 0xF0, // 5
+        0xF0, 0x80, 0xF0, 0x90, 0xF0, // 6
+        0xF0, 0x10, 0x20, 0x40, 0x40, // 7
+        0xF0, 0x90, 0xF0, 0x90, 0xF0, // 8
+        0xF0, 0x90, 0xF0, 0x10, 0xF0, // 9
+        0xF0, 0x90, 0xF0, 0x90, 0x90, // A
+        0xE0, 0x90, 0xE0, 0x90, 0xE0, // B
+        0xF0, 0x80, 0x80, 0x80, 0xF0, // C
+        0xE0, 0x90, 0x90, 0x90, 0xE0, // D
+        0xF0, 0x80, 0xF0, 0x80, 0xF0, // E
+        0xF0, 0x80, 0xF0, 0x80, 0x80  // F
+    };
+
+    memcpy(&state->memory[FONT_START], &font_array, sizeof(font_array));
+}
+
+int LoadRom(char* file_name, uint8_t* memory) {
+    FILE* rom = fopen(file_name, "rb");
+    if (rom == NULL) {
+        return 1;
+    }
+
+    fseek(rom, 0L, SEEK_END);
+    int file_size = ftell(rom);
+    fseek(rom, 0L, SEEK_SET);
+
+    if (fread(memory, file_size, 1, rom) != 1) {
+        return 1;
+    }
 
+    fclose(rom);
+
+    return 0;
+}
+
+// xorshift32: small per-device RNG so instances can be seeded independently.
+uint32_t Xorshift32(uint32_t* state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+
+    return x;
+}
+
+static void MarkStore(Fish* device, int length) {
+    int end = device->i_reg + length > MAX_MEMORY ? MAX_MEMORY : device->i_reg + length;
+
+    if (device->i_reg < device->written_start) device->written_start = device->i_reg;
+    if (end > device->written_end) device->written_end = end;
+}
+
+void EmulateCpu(Fish* device, int is_debug) {
     // Extract opcode data and break down into nibbles.
     uint8_t* current_instr = &device->memory[device->pc];
     uint8_t instr_nib[] = {
@@ -169,7 +240,7 @@ void EmulateCpu(Fish* device, int is_debug) {
         case 0xc: {
             if (is_debug) { printf("%-10s V%01x, #$%02x\n", "RAND", instr_nib[1], current_instr[1]); }
 
-            uint8_t random = (rand() % UINT8_MAX) & current_instr[1];
+            uint8_t random = (Xorshift32(&device->rng_state) % UINT8_MAX) & current_instr[1];
             device->v[instr_nib[1]] = random;
         } break;
         case 0xd: {
@@ -259,6 +330,7 @@ void EmulateCpu(Fish* device, int is_debug) {
                     device->memory[device->i_reg] = (device->v[instr_nib[1]] / 100);
                     device->memory[device->i_reg + 1] = (device->v[instr_nib[1]] / 10) % 10;
                     device->memory[device->i_reg + 2] = device->v[instr_nib[1]] % 10;
+                    MarkStore(device, 3);
                 } break;
                 case 0x55: {
                     if (is_debug) { printf("%-10s I, V0 -> V%01x\n", "LDI.ALL", instr_nib[1]); }
@@ -266,6 +338,7 @@ void EmulateCpu(Fish* device, int is_debug) {
                     for (int i = 0; i <= instr_nib[1]; i++) {
                         device->memory[device->i_reg + i] = device->v[i];
                     }
+                    MarkStore(device, instr_nib[1] + 1);
                 } break;
                 case 0x65: {
                     if (is_debug) { printf("%-10s V0 -> V%01x, I\n", "LDX.ALL", instr_nib[1]); }
@@ -3,6 +3,9 @@
 #ifndef CPU_H
 #define CPU_H
 
+void InitFish(Fish*, ConfigState*);
+int LoadRom(char*, uint8_t*);
+uint32_t Xorshift32(uint32_t*);
 void EmulateCpu(Fish*, int);
 
 #endif // CPU_H
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "fish.h"
 #include "cpu.h"
+#include "capture.h"
+#include "batch.h"
 
 SDL_Window* window = NULL;
 SDL_Renderer* renderer = NULL;
@@ -19,29 +21,85 @@ int buffer_position = 0;
 
 int last_frame_ticks = 0;
 
+CaptureState capture;
+
 ConfigState CreateConfiguration(const int count, char** args) {
     ConfigState config = {0};
 
-    for (int i = 0; i < count; i++) {
-        // Evaluate every item in args[]
-        int char_count = strlen(args[i]);
-
-        int current_char = 0;
-        while (args[i][current_char] != '\0' && current_char < char_count) {
-            if (args[i][current_char] == '-') {
-                switch (args[i][current_char + 1]) {
-                    case 'd': config.debugMode = 1; break;
-                    case 'f': config.deviceFreqency = 1000; break;
-                    case 'r': config.deviceRefresh = 120; break;
+    // args[1] is the ROM path, so a '-' in a file name is never read as a flag.
+    for (int i = 2; i < count; i++) {
+        if (args[i][0] != '-') continue;
+
+        switch (args[i][1]) {
+            case 'd': config.debugMode = 1; break;
+            case 'f': config.deviceFreqency = 1000; break;
+            case 'r': config.deviceRefresh = 120; break;
+            case 'n':
+                config.headlessMode = 1;
+                if (i + 1 < count && isdigit((unsigned char)args[i + 1][0])) {
+                    config.frameLimit = atoi(args[i + 1]);
                 }
-            }
-            current_char++;
+                break;
+            case 'v': config.captureVideo = 1; break;
+            case 'a': config.captureVideo = 1; config.captureAudio = 1; break;
+            case 'b': config.batchLanes = (i + 1 < count) ? atoi(args[i + 1]) : 0; break;
         }
     }
 
     return config;
 }
 
+// Run the ROM headless on `batchLanes` instances seeded 1..N and print a hash of each final display.
+int RunSweep(ConfigState* config, char* file_name) {
+    FishBatch batch;
+    if (!InitBatch(&batch, config->batchLanes, config)) {
+        puts("Failed to allocate batch...");
+        return 1;
+    }
+
+    if (LoadBatchRom(&batch, file_name) != 0) {
+        puts("You are also stupid (file error)");
+        FreeBatch(&batch);
+        return 1;
+    }
+
+    for (int lane = 0; lane < batch.count; lane++) {
+        batch.rng_state[lane] = lane + 1;
+    }
+
+    int frame_limit = config->frameLimit > 0 ? config->frameLimit : SWEEP_FRAMES;
+
+    clock_t start = clock();
+    int frame = 0;
+    int running = batch.count;
+    while (frame < frame_limit && running > 0) {
+        EmulateBatch(&batch, batch.lanes[0].frequency / REFRESH_RATE);
+        UpdateBatchTimers(&batch);
+        frame++;
+
+        running = 0;
+        for (int lane = 0; lane < batch.count; lane++) {
+            running += !batch.lanes[lane].exit_requested;
+        }
+    }
+    double elapsed = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    for (int lane = 0; lane < batch.count; lane++) {
+        // FNV-1a over the display so identical end states are easy to spot.
+        uint32_t hash = 2166136261u;
+        uint8_t* pixels = &batch.lanes[lane].display[0][0];
+        for (int i = 0; i < DISPLAY_HEIGHT * DISPLAY_WIDTH; i++) {
+            hash = (hash ^ pixels[i]) * 16777619u;
+        }
+
+        printf("seed %d: %08x%s\n", lane + 1, hash, batch.lanes[lane].exit_requested ? " (exited)" : "");
+    }
+    printf("%d lanes x %d frames in %.3fs\n", batch.count, frame, elapsed);
+
+    FreeBatch(&batch);
+
+    return 0;
+}
 
 int main(int argc, char** argv) {
     if (argc < 2) {
@@ -51,11 +109,15 @@ int main(int argc, char** argv) {
 
     ConfigState configState = CreateConfiguration(argc, argv);
 
+    if (configState.batchLanes > 0) {
+        return RunSweep(&configState, argv[1]);
+    }
+
     // Setup device
     Fish state = {0};
     InitFish(&state, &configState);
 
-    if (!InitSDL()) { return 1; }
+    if (!InitSDL(configState.headlessMode)) { return 1; }
 
     // Load ROM file into device memory.
     if (LoadRom(argv[1], &state.memory[ROM_START]) != 0) {
@@ -63,15 +125,23 @@ int main(int argc, char** argv) {
         return 1;
     }
 
-    ClearScreen();
+    SDL_AudioDeviceID audio_device = 0;
+    if (!configState.headlessMode) {
+        ClearScreen();
+        audio_device = SDL_OpenAudioDevice(NULL, 0, &spec, NULL, 0);
+    }
 
-    SDL_AudioDeviceID audio_device = SDL_OpenAudioDevice(NULL, 0, &spec, NULL, 0);
+    // Headless captures wait for the writer instead of dropping frames so the output is reproducible.
+    if (configState.captureVideo && !StartCapture(&capture, configState.captureAudio, configState.headlessMode)) {
+        return 1;
+    }
 
     for (int i = 0; i < AUDIO_FREQUENCY; i++) {
         audio_buffer[i] = apply_volume(gen_square(440, i), 0.5);
     }
 
     // Enter SDL loop?
+    int frame_count = 0;
     while (!state.exit_requested) {
         last_frame_ticks = SDL_GetTicks();
 
@@ -84,12 +154,17 @@ int main(int argc, char** argv) {
             EmulateCpu(&state, configState.debugMode);
         }
 
-        if (state.draw_requested) {
+        if (state.draw_requested && !configState.headlessMode) {
             UpdateRenderer(&state);
         }
 
+        if (configState.captureVideo) {
+            CaptureFrame(&capture, &state);
+        }
+
+        // Headless runs are uncapped.
         int render_cost = SDL_GetTicks() - last_frame_ticks;
-        if (render_cost < (1000/REFRESH_RATE)) {
+        if (render_cost < (1000/REFRESH_RATE) && !configState.headlessMode) {
             SDL_Delay((1000/REFRESH_RATE) - render_cost);
         }
 
@@ -98,15 +173,25 @@ int main(int argc, char** argv) {
         if (buffer_position >= AUDIO_FREQUENCY) {
             buffer_position = 0;
         }
+
+        frame_count++;
+        if (configState.frameLimit > 0 && frame_count >= configState.frameLimit) {
+            state.exit_requested = 1;
+        }
     }
 
     // Cleanup
+    int exit_code = 0;
+    if (configState.captureVideo && StopCapture(&capture) != 0) {
+        exit_code = 1;
+    }
+
     SDL_CloseAudioDevice(audio_device);
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
     SDL_Quit();
 
-    return 0;
+    return exit_code;
 }
 
 void InputHandler(Fish* fish, SDL_Event* event) {
@@ -190,70 +275,27 @@ void UpdateTimers(Fish* state, SDL_AudioDeviceID id) {
         state->delay_timer--;
     }
 
-    if (state->sound_timer > 0) {
-        SDL_PauseAudioDevice(id, 0);
+    int sounding = state->sound_timer > 0;
+    if (sounding) {
         state->sound_timer--;
-    } else SDL_PauseAudioDevice(id, 1);
-}
-
-void InitFish(Fish* state, ConfigState* config) {
-    memset(state->display, 0, sizeof(state->display));
-    state->pc = ROM_START;
-    state->sp = 0;
-
-    if (config->deviceFreqency != 0) {
-        state->frequency = config->deviceFreqency;
-    } else state->frequency = 500;
-
-    state->exit_requested = 0;
-
-    uint8_t font_array[] = {
-        0xF0, 0x90, 0x90, 0x90, 0xF0, // 0
-        0x20, 0x60, 0x20, 0x20, 0x70, // 1
-        0xF0, 0x10, 0xF0, 0x80, 0xF0, // 2
-        0xF0, 0x10, 0xF0, 0x10, 0xF0, // 3
-        0x90, 0x90, 0xF0, 0x10, 0x10, // 4
-        0xF0, 0x80, 0xF0, 0x10, 0xF0, // 5
-        0xF0, 0x80, 0xF0, 0x90, 0xF0, // 6
-        0xF0, 0x10, 0x20, 0x40, 0x40, // 7
-        0xF0, 0x90, 0xF0, 0x90, 0xF0, // 8
-        0xF0, 0x90, 0xF0, 0x10, 0xF0, // 9
-        0xF0, 0x90, 0xF0, 0x90, 0x90, // A
-        0xE0, 0x90, 0xE0, 0x90, 0xE0, // B
-        0xF0, 0x80, 0x80, 0x80, 0xF0, // C
-        0xE0, 0x90, 0x90, 0x90, 0xE0, // D
-        0xF0, 0x80, 0xF0, 0x80, 0xF0, // E
-        0xF0, 0x80, 0xF0, 0x80, 0x80  // F
-    };
-
-    memcpy(&state->memory[FONT_START], &font_array, sizeof(font_array));
-}
-
-int LoadRom(char* file_name, uint8_t* memory) {
-    FILE* rom = fopen(file_name, "rb");
-    if (rom == NULL) {
-        return 1;
     }
 
-    fseek(rom, 0L, SEEK_END);
-    int file_size = ftell(rom);
-    fseek(rom, 0L, SEEK_SET);
-
-    if (fread(memory, file_size, 1, rom) != 1) {
-        return 1;
+    // Headless runs never open an audio device.
+    if (id != 0) {
+        SDL_PauseAudioDevice(id, !sounding);
     }
-
-    fclose(rom);
-
-    return 0;
 }
 
-int InitSDL() {
-    if (SDL_Init(SDL_INIT_EVERYTHING) != 0) {
+int InitSDL(int headless) {
+    // Headless runs still need events so SDL_QUIT (Ctrl+C) ends them cleanly.
+    Uint32 subsystems = headless ? (SDL_INIT_EVENTS | SDL_INIT_TIMER) : SDL_INIT_EVERYTHING;
+    if (SDL_Init(subsystems) != 0) {
         puts("SDL initialization error...");
         return 0;
     }
 
+    if (headless) { return 1; }
+
     window = SDL_CreateWindow("Fish8 - 0.0.1", 
                              SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, 
                              DISPLAY_WIDTH * DISPLAY_SCALE, DISPLAY_HEIGHT * DISPLAY_SCALE, 
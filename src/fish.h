@@ -5,6 +5,8 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <math.h>
+#include <time.h>
+#include <ctype.h>
 #include <SDL2/SDL.h>
 
 // System constants
@@ -19,6 +21,9 @@
 #define REFRESH_RATE 60
 #define DISPLAY_SCALE 20
 
+// Frames a -b seed sweep runs for.
+#define SWEEP_FRAMES (REFRESH_RATE * 10)
+
 // Memory locations
 #define FONT_START 0x0000
 #define FONT_STRIDE 5
@@ -28,6 +33,11 @@ typedef struct {
     int debugMode;
     int deviceFreqency;
     int deviceRefresh;
+    int headlessMode;
+    int frameLimit;
+    int captureVideo;
+    int captureAudio;
+    int batchLanes;
 } ConfigState;
 
 typedef struct {
@@ -72,15 +82,20 @@ typedef struct {
     uint8_t keypad_buffer[16];
 
     uint8_t draw_requested;
+
+    // RAND state. Must be non-zero; seeded from the clock unless set by the caller.
+    uint32_t rng_state;
+
+    // Span of memory LDB.X/LDI.ALL have stored to, so a batch knows where lanes' code may differ.
+    uint16_t written_start;
+    uint16_t written_end;
 } Fish;
 
-void InitFish(Fish*, ConfigState*);
 void InputHandler(Fish*, SDL_Event*);
 void UpdateRenderer(Fish*);
 void UpdateTimers(Fish*, SDL_AudioDeviceID);
-int InitSDL();
+int InitSDL(int);
 void ClearScreen();
-int LoadRom(char*, uint8_t*);
 double apply_volume(double, double);
 double gen_sine(double, int);
 double gen_square(double, int);
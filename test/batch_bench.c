@@ -0,0 +1,143 @@
+// Times seed sweeps batched against the same number of independent EmulateCpu loops, on ROMs whose
+// lanes diverge through RAND every iteration.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "../src/cpu.h"
+#include "../src/batch.h"
+
+#define BENCH_LANES 1024
+#define BENCH_FRAMES 2500
+#define BENCH_STEPS 8
+
+// Each side is timed this many times back to back and the best run is reported, to keep other load out of it.
+#define BENCH_RUNS 3
+
+// Lanes split on a one-instruction skip and rejoin at the very next opcode: the best case for lockstep.
+uint8_t skip_rom[] = {
+    0xC4, 0x01, // RAND V4, #$01
+    0x34, 0x00, // SKIP.CMP V4, #$00
+    0x75, 0x01, // ADD V5, #$01
+    0x86, 0x54, // ADD V6, V5
+    0x87, 0x6E, // SHL V7, V6
+    0x88, 0x73, // XOR V8, V7
+    0x12, 0x00  // JMP $200
+};
+
+double Seconds(clock_t start) {
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+// Lanes pick one of `blocks` code blocks through a jump table and only meet again back at $200.
+int BuildJumpTable(uint8_t* rom, int blocks) {
+    int at = 0;
+    uint16_t table = ROM_START + 8;
+    uint16_t code = table + blocks * 2;
+
+    uint16_t head[] = {
+        0xC000 | (blocks - 1), // RAND V0, #blocks-1
+        0x800E,                // SHL V0
+        0xB000 | (table - 2),  // JMP.V $table (the interpreter adds 2 after the jump)
+        0x0000
+    };
+    for (int i = 0; i < 4; i++) {
+        rom[at++] = head[i] >> 8;
+        rom[at++] = head[i] & 0xFF;
+    }
+
+    uint16_t block[] = { 0x7100, 0x8214, 0x832E, 0x8433, 0x1200 };
+    for (int i = 0; i < blocks; i++) {
+        uint16_t jump = 0x1000 | (code + i * sizeof(block));
+        rom[at++] = jump >> 8;
+        rom[at++] = jump & 0xFF;
+    }
+
+    for (int i = 0; i < blocks; i++) {
+        block[0] = 0x7100 | i; // ADD V1, #i
+        for (int j = 0; j < 5; j++) {
+            rom[at++] = block[j] >> 8;
+            rom[at++] = block[j] & 0xFF;
+        }
+    }
+
+    return at;
+}
+
+int Bench(const char* name, uint8_t* rom, int size) {
+    ConfigState config = {0};
+    FishBatch batch;
+    Fish* lanes = calloc(BENCH_LANES, sizeof(Fish));
+
+    if (!InitBatch(&batch, BENCH_LANES, &config) || lanes == NULL) {
+        puts("allocation failed");
+        return 1;
+    }
+
+    for (int lane = 0; lane < BENCH_LANES; lane++) {
+        memcpy(&batch.lanes[lane].memory[ROM_START], rom, size);
+        batch.rng_state[lane] = lane + 1;
+
+        InitFish(&lanes[lane], &config);
+        memcpy(&lanes[lane].memory[ROM_START], rom, size);
+        lanes[lane].rng_state = lane + 1;
+    }
+
+    double scalar = 0;
+    double batched = 0;
+    for (int run = 0; run < BENCH_RUNS; run++) {
+        clock_t start = clock();
+        for (int frame = 0; frame < BENCH_FRAMES; frame++) {
+            for (int lane = 0; lane < BENCH_LANES; lane++) {
+                // Stop at exit like the batch does, so both sides do the same work.
+                for (int step = 0; step < BENCH_STEPS && !lanes[lane].exit_requested; step++) {
+                    EmulateCpu(&lanes[lane], 0);
+                }
+            }
+        }
+        if (run == 0 || Seconds(start) < scalar) scalar = Seconds(start);
+
+        start = clock();
+        for (int frame = 0; frame < BENCH_FRAMES; frame++) {
+            EmulateBatch(&batch, BENCH_STEPS);
+        }
+        if (run == 0 || Seconds(start) < batched) batched = Seconds(start);
+    }
+
+    // Cheap sanity check; test/batch_test.c does the full comparison.
+    SyncBatch(&batch);
+    int mismatches = 0;
+    for (int lane = 0; lane < BENCH_LANES; lane++) {
+        for (int x = 0; x < 16; x++) {
+            mismatches += batch.v[x][lane] != lanes[lane].v[x];
+        }
+        mismatches += batch.pc[lane] != lanes[lane].pc;
+    }
+
+    printf("%-14s independent %.3fs, batched %.3fs (%.1fx)%s\n", name, scalar, batched, scalar / batched,
+           mismatches ? " MISMATCH" : "");
+
+    free(lanes);
+    FreeBatch(&batch);
+
+    return mismatches != 0;
+}
+
+int main() {
+    uint8_t rom[MAX_MEMORY - ROM_START];
+    char name[32];
+    int failed = 0;
+
+    printf("%d lanes x %d instructions, best of %d\n", BENCH_LANES, BENCH_FRAMES * BENCH_STEPS, BENCH_RUNS);
+    failed |= Bench("skip", skip_rom, sizeof(skip_rom));
+
+    for (int blocks = 2; blocks <= 32; blocks *= 2) {
+        snprintf(name, sizeof(name), "jump table/%d", blocks);
+        failed |= Bench(name, rom, BuildJumpTable(rom, blocks));
+    }
+
+    return failed;
+}
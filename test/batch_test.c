@@ -0,0 +1,223 @@
+// Runs random ROMs through EmulateBatch and through independent EmulateCpu loops and checks every lane ends
+// in the same state. Seeds and keypads differ per lane so lanes keep splitting apart and rejoining.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../src/cpu.h"
+#include "../src/batch.h"
+
+#define TEST_ROMS 300
+#define TEST_FRAMES 150
+#define TEST_STEPS 8
+#define SUBROUTINE 0x600
+
+// More than a 16-bit budget holds, so EmulateBatch has to split the call.
+#define LONG_STEPS 70000
+#define LONG_LANES 5
+
+uint32_t test_rng = 0x1234567;
+
+uint8_t Random(int limit) {
+    return Xorshift32(&test_rng) % limit;
+}
+
+int EmitOp(uint8_t* rom, int at, uint16_t op) {
+    rom[at] = op >> 8;
+    rom[at + 1] = op & 0xFF;
+    return at + 2;
+}
+
+// V0-VA take random values, VB holds a key (0-F), VC/VE sprite coordinates and VD = 1 so I only creeps
+// forward. That keeps every lane inside its own Fish, which is what the interpreter needs to be comparable.
+uint16_t RandomOp(int allow_branches) {
+    uint8_t x = Random(0xB);
+    uint8_t y = Random(0x10);
+    uint8_t kk = Random(0x100);
+    uint8_t alu[] = { 0x0, 0x1, 0x2, 0x3, 0x4, 0x5, 0x6, 0x7, 0xE };
+
+    switch (Random(allow_branches ? 20 : 12)) {
+        case 0: return 0x6000 | x << 8 | kk;
+        case 1: return 0x7000 | x << 8 | kk;
+        case 2: case 3: case 4: return 0x8000 | x << 8 | y << 4 | alu[Random(sizeof(alu))];
+        case 5: return 0xC000 | x << 8 | kk;
+        case 6: return 0xA800 | kk;
+        case 7: return 0xF033 | x << 8;
+        case 8: return 0xF055 | x << 8;
+        case 9: return 0xF065 | x << 8;
+        case 10: return 0xF007 | x << 8;
+        case 11: return 0xFD1E;
+        case 12: return 0x3000 | x << 8 | (kk & 3);
+        case 13: return 0x4000 | x << 8 | (kk & 3);
+        case 14: return 0x5000 | x << 8 | y << 4;
+        case 15: return 0x9000 | x << 8 | y << 4;
+        case 16: return Random(2) ? 0xEB9E : 0xEBA1;
+        case 17: return 0xF015 | x << 8;
+        case 18: return 0xF018 | x << 8;
+        default: return 0x2000 | SUBROUTINE;
+    }
+}
+
+void BuildRom(uint8_t* memory) {
+    int at = ROM_START;
+    at = EmitOp(memory, at, 0x6D01);
+
+    for (int i = 0; i < 120; i++) {
+        switch (Random(12)) {
+            case 0: {
+                at = EmitOp(memory, at, 0x6C00 | Random(56));
+                at = EmitOp(memory, at, 0x6E00 | Random(27));
+                at = EmitOp(memory, at, 0xF029 | Random(0xB) << 8);
+                at = EmitOp(memory, at, 0xDCE0 | (1 + Random(5)));
+            } break;
+            case 1: at = EmitOp(memory, at, 0x6B00 | Random(0x10)); break;
+            case 2: at = EmitOp(memory, at, 0xF00A | Random(0xB) << 8); break;
+            default: at = EmitOp(memory, at, RandomOp(1)); break;
+        }
+    }
+
+    // Doubled so a skip on the last op still loops.
+    at = EmitOp(memory, at, 0x1200);
+    at = EmitOp(memory, at, 0x1200);
+
+    // Straight-line subroutine so a skip can never jump over its RET.
+    at = SUBROUTINE;
+    for (int i = 0; i < 6; i++) {
+        at = EmitOp(memory, at, RandomOp(0));
+    }
+    EmitOp(memory, at, 0x00EE);
+}
+
+int CompareLane(FishBatch* batch, int lane, Fish* expected) {
+    Fish* fish = &batch->lanes[lane];
+
+    for (int x = 0; x < 16; x++) {
+        if (batch->v[x][lane] != expected->v[x]) return 0;
+    }
+
+    return batch->pc[lane] == expected->pc &&
+           batch->i_reg[lane] == expected->i_reg &&
+           batch->rng_state[lane] == expected->rng_state &&
+           fish->sp == expected->sp &&
+           fish->delay_timer == expected->delay_timer &&
+           fish->sound_timer == expected->sound_timer &&
+           fish->exit_requested == expected->exit_requested &&
+           memcmp(fish->stack, expected->stack, sizeof(fish->stack)) == 0 &&
+           memcmp(fish->keypad_buffer, expected->keypad_buffer, sizeof(fish->keypad_buffer)) == 0 &&
+           memcmp(fish->memory, expected->memory, sizeof(fish->memory)) == 0 &&
+           memcmp(fish->display, expected->display, sizeof(fish->display)) == 0;
+}
+
+// One call far longer than a frame, so EmulateBatch has to split it into several lockstep passes.
+int TestLongRun() {
+    ConfigState config = {0};
+    FishBatch batch;
+    Fish expected[LONG_LANES] = {0};
+    int failures = 0;
+
+    if (!InitBatch(&batch, LONG_LANES, &config)) {
+        puts("allocation failed");
+        return 1;
+    }
+
+    BuildRom(batch.lanes[0].memory);
+    for (int lane = 0; lane < LONG_LANES; lane++) {
+        memcpy(batch.lanes[lane].memory, batch.lanes[0].memory, MAX_MEMORY);
+        batch.rng_state[lane] = lane + 1;
+
+        InitFish(&expected[lane], &config);
+        memcpy(expected[lane].memory, batch.lanes[0].memory, MAX_MEMORY);
+        expected[lane].rng_state = lane + 1;
+    }
+
+    EmulateBatch(&batch, LONG_STEPS);
+    SyncBatch(&batch);
+
+    for (int lane = 0; lane < LONG_LANES; lane++) {
+        for (int step = 0; step < LONG_STEPS && !expected[lane].exit_requested; step++) {
+            EmulateCpu(&expected[lane], 0);
+        }
+
+        if (!CompareLane(&batch, lane, &expected[lane])) {
+            printf("FAIL: %d step run, lane %d\n", LONG_STEPS, lane);
+            failures++;
+        }
+    }
+
+    FreeBatch(&batch);
+
+    return failures;
+}
+
+int main() {
+    ConfigState config = {0};
+    int lane_counts[] = { 1, 7, 64, 100 };
+    int failures = 0;
+    long steps = 0;
+
+    for (int rom = 0; rom < TEST_ROMS; rom++) {
+        int count = lane_counts[rom % 4];
+        FishBatch batch;
+        Fish* expected = calloc(count, sizeof(Fish));
+
+        if (!InitBatch(&batch, count, &config) || expected == NULL) {
+            puts("allocation failed");
+            return 1;
+        }
+
+        BuildRom(batch.lanes[0].memory);
+        for (int lane = 0; lane < count; lane++) {
+            memcpy(batch.lanes[lane].memory, batch.lanes[0].memory, MAX_MEMORY);
+
+            // Pairs of lanes share a seed so some of them stay together.
+            batch.rng_state[lane] = lane / 2 + 1;
+
+            InitFish(&expected[lane], &config);
+            memcpy(expected[lane].memory, batch.lanes[0].memory, MAX_MEMORY);
+            expected[lane].rng_state = lane / 2 + 1;
+        }
+
+        for (int frame = 0; frame < TEST_FRAMES; frame++) {
+            for (int lane = 0; lane < count; lane++) {
+                for (int key = 0; key < 16; key++) {
+                    uint8_t pressed = Random(8) == 0;
+                    batch.lanes[lane].keypad[key] = pressed;
+                    expected[lane].keypad[key] = pressed;
+                }
+            }
+
+            EmulateBatch(&batch, TEST_STEPS);
+            UpdateBatchTimers(&batch);
+
+            for (int lane = 0; lane < count; lane++) {
+                for (int step = 0; step < TEST_STEPS && !expected[lane].exit_requested; step++) {
+                    EmulateCpu(&expected[lane], 0);
+                }
+
+                if (expected[lane].delay_timer > 0) expected[lane].delay_timer--;
+                if (expected[lane].sound_timer > 0) expected[lane].sound_timer--;
+            }
+            steps += (long)count * TEST_STEPS;
+        }
+
+        SyncBatch(&batch);
+        for (int lane = 0; lane < count; lane++) {
+            if (!CompareLane(&batch, lane, &expected[lane])) {
+                printf("FAIL: rom %d lane %d of %d\n", rom, lane, count);
+                failures++;
+                break;
+            }
+        }
+
+        free(expected);
+        FreeBatch(&batch);
+    }
+
+    failures += TestLongRun();
+
+    printf("%d ROMs, %ld lane steps, %d failures\n", TEST_ROMS, steps, failures);
+
+    return failures != 0;
+}